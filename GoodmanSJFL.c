@@ -10,12 +10,47 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 // INCLUDES
+#define _GNU_SOURCE
+#include <getopt.h>
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
+////////////////////////////////////////////////////////////////////////////////
+//CONSTANTS
+#define HIST_SUB_BITS 3
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((32 - HIST_SUB_BITS) * HIST_SUB)
+#define POLICY_SJF 0
+#define POLICY_SJFL 1
+#define POLICY_PRIORITY 2
+#define POLICY_RR 3
+#define MAX_POLICIES 16
+#define RESULT_COLUMNS 6
+#define RESULT_CHUNK 4096
+#define TRACE_RING_SIZE (1 << 16)
+#define MAX_TRACE_RINGS 64
+#define SWEEP_BLOCK_BYTES (128 * 1024)
+#define MAX_ALPHAS 64
+#define MAX_NODES 64
+#define MC_EXPONENTIAL 0
+#define MC_UNIFORM 1
+#define MC_BIMODAL 2
+
 ////////////////////////////////////////////////////////////////////////////////
 //DATA STRUCTURES
 typedef struct Process {
@@ -23,23 +58,206 @@ typedef struct Process {
     int tau;
     float alpha;
     int* t;
+    long* marks;
 } Process;
 
+typedef struct Histogram {
+    long long count;
+    int max;
+    unsigned long long buckets[HIST_BUCKETS];
+} Histogram;
+
+typedef struct ResultsChunk {
+    char magic[4];
+    char policy[12];
+    int rows;
+    int columns[RESULT_COLUMNS][RESULT_CHUNK];
+} ResultsChunk;
+
+typedef struct TraceEvent {
+    int policy;
+    int tick;
+    int pid;
+    int tauBefore;
+    int burst;
+    int tauAfter;
+} TraceEvent;
+
+typedef struct TraceRing {
+    _Alignas(64) atomic_ulong head;
+    _Alignas(64) atomic_ulong tail;
+    _Alignas(64) TraceEvent events[TRACE_RING_SIZE];
+} TraceRing;
+
+typedef struct SweepTrace {
+    const char* name;
+    int numTicks;
+    int numProcesses;
+    Process* rows;
+} SweepTrace;
+
+typedef struct SweepTotals {
+    int runningTime;
+    int waitingTime;
+    int error;
+} SweepTotals;
+
+typedef struct MonteCarloResult {
+    double waitDiff;
+    double turnAroundDiff;
+    double error;
+} MonteCarloResult;
+
+typedef struct SnapshotHeader {
+    char magic[8];
+    long dataSize;
+    long dataModified;
+    int numTicks;
+    int numProcesses;
+    int tick;
+    int runningTime;
+    int waitingTime;
+    int error;
+} SnapshotHeader;
+
+typedef struct SnapshotEntry {
+    int processID;
+    int tau;
+    float alpha;
+    long offset;
+} SnapshotEntry;
+
 ////////////////////////////////////////////////////////////////////////////////
 //GLOBAL VARIABLES
 int numProcesses, numTicks, turnAroundTime = 0, waitingTime = 0, error = 0, runningTime = 0;
 Process* processes = NULL;
+long dataSize = 0, dataModified = 0;
+char* checkpointFile = NULL;
+char* resumeFile = NULL;
+char* indexFile = NULL;
+char* resultsFile = NULL;
+int resultsFd = -1, resultsCsv = 0, summaryOnly = 0;
+ResultsChunk resultsChunk;
+long memoryBudget = 0;
+char* mapped = NULL;
+size_t mappedSize = 0;
+long* rowStarts = NULL;
+long* cursors = NULL;
+int* blockBuffers[2] = {NULL, NULL};
+int blockTicks = 0, tickBase = 0, frontBuffer = 0, blockState = 0, blockStart = 0, blockCount = 0, prefetchStopping = 0;
+pthread_t prefetchThread;
+const char* policyTitles[] = {"Shortest-Job-First", "Shortest-Job-First Live", "Priority", "Round-Robin"};
+char* traceFile = NULL;
+char* replayFile = NULL;
+FILE* traceOut = NULL;
+int tracing = 0;
+pthread_t traceThread;
+_Atomic(TraceRing*) traceRings[MAX_TRACE_RINGS];
+atomic_int traceRingCount = 0, traceStopping = 0;
+int traceWriteError = 0;
+_Thread_local TraceRing* localRing = NULL;
+float alphas[MAX_ALPHAS];
+int numAlphas = 0, numSweepTraces = 0, numaPlacement = 0;
+SweepTrace* sweepTraces = NULL;
+SweepTotals* sweepTotals = NULL;
+int* sweepCpus = NULL;
+int numSweepCpus = 0;
+long mcScenarios = 0, verifyTraces = 0;
+double maxNanoseconds = 0.0, maxRatio = 0.0;
+int mcWorkers = 0, mcDistribution = MC_EXPONENTIAL;
+double mcParams[3] = {10.0, 0.0, 0.0};
+unsigned long long mcSeed = 1;
+pthread_mutex_t blockLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t blockChanged = PTHREAD_COND_INITIALIZER;
+FILE* indexOut = NULL;
+int quiet = 0, quantum = 4, lastTurnAroundTime = 0, lastWaitingTime = 0, lastError = 0;
+int* rrRemaining = NULL;
+int* rrDone = NULL;
+int markEvery = 0, firstTick = 0, lastTick = 0, printFrom = 0, buildIndex = 0, windowFrom = -1, windowTo = 0;
+SnapshotHeader* stagedSnapshot = NULL;
+SnapshotHeader* indexSnapshot = NULL;
+int snapshotPending = 0, checkpointStopping = 0;
+pthread_t checkpointThread;
+pthread_mutex_t checkpointLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t checkpointReady = PTHREAD_COND_INITIALIZER;
+char* histogramFile = NULL;
+FILE* histogramOut = NULL;
+Histogram* waitHistograms = NULL;
+Histogram turnAroundHistogram, errorHistogram;
 
 ////////////////////////////////////////////////////////////////////////////////
 //FORWARD DECLARATIONS
 void readFile(char* filename);
 Process* readProcesses(FILE* file);
+SnapshotEntry* readStartSnapshot();
+Process* mapProcesses(FILE* file);
+int parseInt(long* pos);
+float parseFloat(long* pos);
+long skipTokens(long pos, int count);
+void parseBlock(int* buffer, int start, int count);
+void beginBlocks(int from, int to);
+void nextBlock(int tick, int to);
+void* blockPrefetcher(void* arg);
+void stopBlocks();
+void checkDuplicateIDs();
+unsigned int hashID(int processID);
+void readSnapshot(FILE* snapshot, const char* name, SnapshotEntry* entries);
+void seekIndexSnapshot(FILE* index);
+void fillSnapshot(SnapshotHeader* snapshot, int tick);
+void appendIndex(int tick);
+void startIndex();
+void stopIndex();
+void failIndex();
+size_t snapshotSize();
+void startCheckpoints();
+void stageCheckpoint(int tick);
+void* checkpointWriter(void* arg);
+void stopCheckpoints();
+void startResults();
+void appendResult(const char* policy, int tick, int start, int j, int estimate, int burst, int wait);
+void flushResults();
+void writeResults(struct iovec* parts, int count);
+void startTrace();
+TraceRing* registerTraceRing();
+void traceEvent(int policy, int tick, int pid, int tauBefore, int burst, int tauAfter);
+unsigned long drainRing(TraceRing* ring);
+void* traceDrainer(void* arg);
+void stopTrace();
+void replayTrace();
+void startHistograms();
+static inline void recordValue(Histogram* h, int value);
+void mergeHistogram(Histogram* into, const Histogram* from);
+static inline int bucketIndex(int value);
+int bucketHighest(int index);
+int valueAtPercentile(const Histogram* h, double percentile);
+void dumpHistogram(const char* label, const Histogram* h);
+void reportHistograms(const char* policy, long chainedTicks);
 void printSJF();
 void printSJFL();
+void printPriority();
+void printRoundRobin();
+void referenceSJF();
+void referenceSJFL();
+int runBenchmark(int repeats);
+void shapeEdgeCase(int kind);
+int* transposeBursts(Process* rows, int n, int ticks);
+void sweepTrace(const SweepTrace* trace, const int* bursts, SweepTotals* totals);
+void planPlacement();
+void* sweepWorker(void* arg);
+void runSweep(int count, char** files);
+int runVerify(long traces);
+int verifySweep(long s, int* initialTau);
+double counterRandom(long scenario, int stream, long counter);
+unsigned long long mix64(unsigned long long x);
+int drawBurst(double u, double v);
+void generateScenario(long scenario);
+void generateTrace(const char* shape);
+void runMonteCarlo(const char* shape);
+void reportInterval(const char* label, MonteCarloResult* results, size_t field);
 void SJFSort(int* p, int* t, int n);
 void SJFLSort(int* p, int* t, int* tau, int n);
 void swap(int* x, int* y);
-void terminate();
+void terminate(int status);
 
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -49,76 +267,733 @@ void terminate();
 */
 void readFile(char* filename){
     FILE* file = fopen(filename, "r");
+    struct stat info;
+    fstat(fileno(file), &info);
+    dataSize = (long)info.st_size;
+    dataModified = (long)info.st_mtim.tv_sec * 1000000000L + info.st_mtim.tv_nsec;
     fscanf(file, "%d", &numTicks);
     fscanf(file, "%d", &numProcesses);
-    processes = readProcesses(file);
+    lastTick = numTicks;
+    if(windowFrom >= 0 || buildIndex){
+        indexFile = (char*)malloc(strlen(filename) + 5);
+        sprintf(indexFile, "%s.idx", filename);
+    }
+    if(memoryBudget > 0)
+        processes = mapProcesses(file);
+    else
+        processes = readProcesses(file);
     fclose(file);
 }
 
 /**
-* Loads process data from data file
+* Restores SJFL state from a checkpoint or index snapshot so that only
+* the bursts following it need to be loaded. The snapshot must carry the
+* data file's current size and modification time, so one taken from an
+* edited trace of the same shape is refused.
+* @param snapshot is the file pointer, positioned at the snapshot
+* @param name is the file name used in error messages
+* @param entries receives the per-process snapshot entries
+*/
+void readSnapshot(FILE* snapshot, const char* name, SnapshotEntry* entries){
+    SnapshotHeader header;
+    if(snapshot == NULL
+       || fread(&header, sizeof(SnapshotHeader), 1, snapshot) != 1
+       || memcmp(header.magic, "SJFLCKP2", 8) != 0
+       || header.dataSize != dataSize
+       || header.dataModified != dataModified
+       || header.numTicks != numTicks
+       || header.numProcesses != numProcesses
+       || fread(entries, sizeof(SnapshotEntry), numProcesses, snapshot) != (size_t)numProcesses){
+        printf("Checkpoint %s is missing or does not match the data file.\n", name);
+        exit(1);
+    }
+    firstTick = header.tick;
+    runningTime = header.runningTime;
+    waitingTime = header.waitingTime;
+    error = header.error;
+    turnAroundTime = runningTime + waitingTime;
+}
+
+/**
+* Positions the index at the last snapshot taken at or before the start
+* of the requested window. Snapshots are fixed-size and evenly spaced, so
+* this is a single seek. An index whose first snapshot does not carry the
+* data file's current stamp and shape was built from another version of
+* the trace and is refused.
+* @param index is the index file pointer
+*/
+void seekIndexSnapshot(FILE* index){
+    SnapshotHeader header;
+    long count, k = 0, size = (long)snapshotSize();
+    if(index == NULL){
+        printf("Index %s does not exist. Build it with --build-index.\n", indexFile);
+        exit(1);
+    }
+    if(fread(&header, sizeof(SnapshotHeader), 1, index) != 1
+       || memcmp(header.magic, "SJFLCKP2", 8) != 0
+       || header.dataSize != dataSize
+       || header.dataModified != dataModified
+       || header.numTicks != numTicks
+       || header.numProcesses != numProcesses){
+        printf("Index %s is out of date with the data file. Rebuild it with --build-index.\n", indexFile);
+        exit(1);
+    }
+    fseek(index, 0, SEEK_END);
+    count = ftell(index) / size;
+    if(count > 1){
+        fseek(index, size, SEEK_SET);
+        if(fread(&header, sizeof(SnapshotHeader), 1, index) == 1 && header.tick > 0)
+            k = windowFrom / header.tick;
+        if(k > count - 1)
+            k = count - 1;
+    }
+    fseek(index, k * size, SEEK_SET);
+}
+
+/**
+* Loads the checkpoint or index snapshot the run starts from, if any
+* @return the per-process snapshot entries, or NULL when starting at tick 0
+*/
+SnapshotEntry* readStartSnapshot(){
+    SnapshotEntry* entries = NULL;
+    FILE* snapshot;
+    if(resumeFile != NULL){
+        entries = (SnapshotEntry*)malloc(numProcesses * sizeof(SnapshotEntry));
+        snapshot = fopen(resumeFile, "rb");
+        readSnapshot(snapshot, resumeFile, entries);
+        fclose(snapshot);
+    } else if(windowFrom >= 0){
+        entries = (SnapshotEntry*)malloc(numProcesses * sizeof(SnapshotEntry));
+        snapshot = fopen(indexFile, "rb");
+        seekIndexSnapshot(snapshot);
+        readSnapshot(snapshot, indexFile, entries);
+        fclose(snapshot);
+        printFrom = windowFrom;
+        if(windowTo < lastTick)
+            lastTick = windowTo;
+    }
+    return entries;
+}
+
+/**
+* Loads process data from data file. Only ticks firstTick..lastTick-1
+* are kept, so t is indexed relative to tickBase.
 * @param file is the file pointer
 */
 Process* readProcesses(FILE* file){
     int i, j;
+    SnapshotEntry* entries;
+    processes = (Process*)malloc(numProcesses * sizeof(Process));
+    entries = readStartSnapshot();
+    tickBase = firstTick;
+    for(i = 0; i < numProcesses; i++){
+        processes[i].t = (int*)malloc(sizeof(int) * (lastTick - firstTick));
+        processes[i].marks = NULL;
+        if(markEvery > 0)
+            processes[i].marks = (long*)malloc(sizeof(long) * (numTicks / markEvery + 1));
+        if(entries != NULL){
+            processes[i].processID = entries[i].processID;
+            processes[i].tau = entries[i].tau;
+            processes[i].alpha = entries[i].alpha;
+            fseek(file, entries[i].offset, SEEK_SET);
+        } else {
+            fscanf(file, "%d %d %f", &processes[i].processID, &processes[i].tau, &processes[i].alpha);
+        }
+        for(j = firstTick; j < lastTick; j++) {
+            if(markEvery > 0 && j % markEvery == 0)
+                processes[i].marks[j / markEvery] = ftell(file);
+            fscanf(file, "%d", &processes[i].t[j - firstTick]);
+        }
+    }
+    free(entries);
+    checkDuplicateIDs();
+    return processes;
+}
+
+/**
+* Maps the data file instead of loading it. Only each row's header and
+* the byte offset of its first burst are kept; bursts are parsed one
+* block of ticks at a time, sized so two blocks fit the memory budget.
+* @param file is the file pointer, positioned after the file header
+*/
+Process* mapProcesses(FILE* file){
+    int i;
+    long pos = ftell(file);
+    struct stat info;
+    SnapshotEntry* entries;
+    fstat(fileno(file), &info);
+    mappedSize = (size_t)info.st_size;
+    mapped = (char*)mmap(NULL, mappedSize, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if(mapped == MAP_FAILED){
+        printf("Cannot map data file.\n");
+        exit(1);
+    }
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
     processes = (Process*)malloc(numProcesses * sizeof(Process));
+    rowStarts = (long*)malloc(numProcesses * sizeof(long));
+    cursors = (long*)malloc(numProcesses * sizeof(long));
+    entries = readStartSnapshot();
     for(i = 0; i < numProcesses; i++){
-        processes[i].t = (int*)malloc(sizeof(int) * numTicks);
-        fscanf(file, "%d %d %f", &processes[i].processID, &processes[i].tau, &processes[i].alpha);
-        for(j = 0; j < numTicks; j++) {
-            fscanf(file, "%d", &processes[i].t[j]);
+        processes[i].marks = NULL;
+        if(markEvery > 0)
+            processes[i].marks = (long*)malloc(sizeof(long) * (numTicks / markEvery + 1));
+        if(entries != NULL){
+            processes[i].processID = entries[i].processID;
+            processes[i].tau = entries[i].tau;
+            processes[i].alpha = entries[i].alpha;
+            rowStarts[i] = entries[i].offset;
+        } else {
+            processes[i].processID = parseInt(&pos);
+            processes[i].tau = parseInt(&pos);
+            processes[i].alpha = parseFloat(&pos);
+            rowStarts[i] = pos;
+            pos = skipTokens(pos, numTicks);
         }
     }
+    free(entries);
+    blockTicks = (int)(memoryBudget / (2L * numProcesses * (long)sizeof(int)));
+    if(blockTicks > lastTick - firstTick)
+        blockTicks = lastTick - firstTick;
+    if(blockTicks < 1)
+        blockTicks = 1;
+    blockBuffers[0] = (int*)malloc((size_t)numProcesses * blockTicks * sizeof(int));
+    blockBuffers[1] = (int*)malloc((size_t)numProcesses * blockTicks * sizeof(int));
+    pthread_create(&prefetchThread, NULL, blockPrefetcher, NULL);
+    checkDuplicateIDs();
     return processes;
 }
 
 /**
-* Prints SJF data to console
+* Parses an integer from the mapped data file
+* @param pos is the byte offset to start at; it is moved past the number
+* @return the value
+*/
+int parseInt(long* pos){
+    long i = *pos;
+    int value = 0, negative = 0;
+    while(i < (long)mappedSize && isspace((unsigned char)mapped[i]))
+        i++;
+    if(i < (long)mappedSize && mapped[i] == '-'){
+        negative = 1;
+        i++;
+    }
+    while(i < (long)mappedSize && mapped[i] >= '0' && mapped[i] <= '9')
+        value = value * 10 + (mapped[i++] - '0');
+    *pos = i;
+    return negative ? -value : value;
+}
+
+/**
+* Parses a float from the mapped data file
+* @param pos is the byte offset to start at; it is moved past the number
+* @return the value
+*/
+float parseFloat(long* pos){
+    char token[32];
+    int n = 0;
+    long i = *pos;
+    while(i < (long)mappedSize && isspace((unsigned char)mapped[i]))
+        i++;
+    while(i < (long)mappedSize && !isspace((unsigned char)mapped[i]) && n < 31)
+        token[n++] = mapped[i++];
+    token[n] = '\0';
+    *pos = i;
+    return strtof(token, NULL);
+}
+
+/**
+* Skips whitespace-separated tokens in the mapped data file
+* @param pos is the byte offset to start at
+* @param count is the number of tokens to skip
+* @return the offset just past the last skipped token
+*/
+long skipTokens(long pos, int count){
+    while(count-- > 0){
+        while(pos < (long)mappedSize && isspace((unsigned char)mapped[pos]))
+            pos++;
+        while(pos < (long)mappedSize && !isspace((unsigned char)mapped[pos]))
+            pos++;
+    }
+    return pos;
+}
+
+/**
+* Parses one block of ticks for every process, continuing each row from
+* its cursor. Pages already consumed are released and the pages the next
+* block is expected to touch are requested ahead of time.
+* @param buffer receives count bursts per process, process by process
+* @param start is the first tick of the block
+* @param count is the number of ticks in the block
+*/
+void parseBlock(int* buffer, int start, int count){
+    int j, k;
+    long pos, page = sysconf(_SC_PAGESIZE), from, length;
+    for(j = 0; j < numProcesses; j++){
+        pos = cursors[j];
+        for(k = 0; k < count; k++){
+            if(markEvery > 0 && (start + k) % markEvery == 0)
+                processes[j].marks[(start + k) / markEvery] = pos;
+            buffer[j * blockTicks + k] = parseInt(&pos);
+        }
+        from = cursors[j] - cursors[j] % page;
+        length = pos - from;
+        madvise(mapped + from, (size_t)(length - length % page), MADV_DONTNEED);
+        if(pos < (long)mappedSize){
+            length = pos - cursors[j];
+            if(length > (long)mappedSize - pos)
+                length = (long)mappedSize - pos;
+            madvise(mapped + (pos - pos % page), (size_t)(length + pos % page), MADV_WILLNEED);
+        }
+        cursors[j] = pos;
+    }
+}
+
+/**
+* Rewinds every row to the first tick and parses the first block
+* synchronously, then asks the prefetcher for the next one
+* @param from is the first tick to simulate
+* @param to is one past the last tick to simulate
+*/
+void beginBlocks(int from, int to){
+    int j;
+    pthread_mutex_lock(&blockLock);
+    while(blockState == 1)
+        pthread_cond_wait(&blockChanged, &blockLock);
+    blockState = 0;
+    pthread_mutex_unlock(&blockLock);
+    for(j = 0; j < numProcesses; j++)
+        cursors[j] = rowStarts[j];
+    frontBuffer = 0;
+    tickBase = from;
+    blockCount = to - from < blockTicks ? to - from : blockTicks;
+    if(blockCount > 0)
+        parseBlock(blockBuffers[0], from, blockCount);
+    for(j = 0; j < numProcesses; j++)
+        processes[j].t = blockBuffers[0] + j * blockTicks;
+    nextBlock(-1, to);
+}
+
+/**
+* Moves to the block the prefetcher has parsed and asks it for the one
+* after. Called with tick -1 only to issue the first request.
+* @param tick is the first tick of the block being moved to
+* @param to is one past the last tick to simulate
+*/
+void nextBlock(int tick, int to){
+    int j;
+    pthread_mutex_lock(&blockLock);
+    if(tick >= 0){
+        while(blockState != 2)
+            pthread_cond_wait(&blockChanged, &blockLock);
+        frontBuffer = 1 - frontBuffer;
+        tickBase = tick;
+        for(j = 0; j < numProcesses; j++)
+            processes[j].t = blockBuffers[frontBuffer] + j * blockTicks;
+    }
+    blockState = 0;
+    if(tickBase + blockTicks < to){
+        blockStart = tickBase + blockTicks;
+        blockCount = to - blockStart < blockTicks ? to - blockStart : blockTicks;
+        blockState = 1;
+        pthread_cond_broadcast(&blockChanged);
+    }
+    pthread_mutex_unlock(&blockLock);
+}
+
+/**
+* Parses requested blocks into the back buffer while the engine works
+* on the front one
+* @param arg is unused
+* @return NULL
+*/
+void* blockPrefetcher(void* arg){
+    pthread_mutex_lock(&blockLock);
+    for(;;){
+        while(blockState != 1 && !prefetchStopping)
+            pthread_cond_wait(&blockChanged, &blockLock);
+        if(blockState != 1)
+            break;
+        pthread_mutex_unlock(&blockLock);
+        parseBlock(blockBuffers[1 - frontBuffer], blockStart, blockCount);
+        pthread_mutex_lock(&blockLock);
+        blockState = 2;
+        pthread_cond_broadcast(&blockChanged);
+    }
+    pthread_mutex_unlock(&blockLock);
+    return arg;
+}
+
+/**
+* Stops the prefetcher and releases the mapping and block buffers
+*/
+void stopBlocks(){
+    pthread_mutex_lock(&blockLock);
+    prefetchStopping = 1;
+    pthread_cond_broadcast(&blockChanged);
+    pthread_mutex_unlock(&blockLock);
+    pthread_join(prefetchThread, NULL);
+    munmap(mapped, mappedSize);
+    free(blockBuffers[0]);
+    free(blockBuffers[1]);
+    free(rowStarts);
+    free(cursors);
+    mapped = NULL;
+}
+
+/**
+* Rejects a data file that lists the same process ID twice. Processes are
+* addressed by their position in the file everywhere else and the ID is
+* only printed, so the table of positions is dropped once checked; its
+* size follows the process count, never the largest ID.
+*/
+void checkDuplicateIDs(){
+    int i;
+    unsigned int capacity = 16, slot;
+    int* slots;
+    while(capacity < 2u * (unsigned int)numProcesses)
+        capacity <<= 1;
+    slots = (int*)malloc(capacity * sizeof(int));
+    for(slot = 0; slot < capacity; slot++)
+        slots[slot] = -1;
+    for(i = 0; i < numProcesses; i++){
+        slot = hashID(processes[i].processID) & (capacity - 1);
+        while(slots[slot] != -1){
+            if(processes[slots[slot]].processID == processes[i].processID){
+                printf("Duplicate process ID %d in data file.\n", processes[i].processID);
+                free(slots);
+                terminate(1);
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+        slots[slot] = i;
+    }
+    free(slots);
+}
+
+/**
+* Scrambles a process ID so clustered IDs spread over the table
+* @param processID is the ID to hash
+* @return the hash value
+*/
+unsigned int hashID(int processID){
+    unsigned int h = (unsigned int)processID;
+    h ^= h >> 16;
+    h *= 0x45d9f3bu;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+* Defines print<NAME>(), the tick loop for one scheduling policy ID. The
+* policy is supplied as static inline traits named <PREFIX>Prepare,
+* <PREFIX>Key, <PREFIX>Wait, <PREFIX>Estimate, <PREFIX>Report and
+* <PREFIX>Update, plus <PREFIX>ProcessWaits and <PREFIX>ChainedStarts
+* constants, which are used directly so each expansion compiles to its
+* own tight loop. "Waiting time" adds the first process's burst each
+* tick for every policy, as the original loops did, so the policies stay
+* comparable. <PREFIX>ProcessWaits also reports the sum of every
+* process's <PREFIX>Wait as "Process waiting time". <PREFIX>ChainedStarts
+* marks policies where each process starts when the previous one
+* finishes, so a process's turnaround within the tick is the next one's
+* wait and only the tick's length needs recording for the turnaround
+* histogram. STATEFUL policies carry tau across ticks; only they take
+* part in checkpoints, the tick index and tick windows.
+*/
+#define DEFINE_TICK_ENGINE(NAME, PREFIX, ID, STATEFUL)                                         \
+void print##NAME(){                                                                            \
+    int i, j, start, tickStart, procWait, verbose, record, estimate;                           \
+    long processWaitingTime = 0;                                                               \
+    int from = STATEFUL ? firstTick : 0, to = STATEFUL ? lastTick : numTicks;                  \
+    int p[numProcesses], t[numProcesses], key[numProcesses];                                   \
+    if(!quiet)                                                                                 \
+        printf("==%s==\n", policyTitles[ID]);                                                  \
+    if(STATEFUL && !quiet && resumeFile != NULL)                                               \
+        printf("Resuming from checkpoint at tick %d\n", firstTick);                            \
+    if(STATEFUL && !quiet && windowFrom >= 0)                                                  \
+        printf("Seeded from index snapshot at tick %d\n", firstTick);                          \
+    if(memoryBudget > 0)                                                                       \
+        beginBlocks(from, to);                                                                 \
+    for(i = from; i < to; i++) {                                                               \
+        if(memoryBudget > 0 && i - tickBase >= blockTicks)                                     \
+            nextBlock(i, to);                                                                  \
+        if(STATEFUL && checkpointFile != NULL && i > firstTick && i % markEvery == 0)          \
+            stageCheckpoint(i);                                                                \
+        if(STATEFUL && indexOut != NULL && i % markEvery == 0)                                 \
+            appendIndex(i);                                                                    \
+        record = resultsFd >= 0 && (!STATEFUL || i >= printFrom);                              \
+        verbose = !quiet && !summaryOnly && (!STATEFUL || i >= printFrom);                     \
+        tickStart = runningTime;                                                               \
+        if(verbose)                                                                            \
+            printf("Simulating %dth tick of processes @ time %d:\n", i, runningTime);          \
+        for (j = 0; j < numProcesses; j++) {                                                   \
+            p[j] = j;                                                                          \
+            t[j] = processes[j].t[i - tickBase];                                               \
+        }                                                                                      \
+        PREFIX##Prepare(t);                                                                    \
+        for (j = 0; j < numProcesses; j++)                                                     \
+            key[j] = PREFIX##Key(j, t[j]);                                                     \
+        SJFLSort(p, t, key, numProcesses);                                                     \
+        for (j = 0, start = 0; j < numProcesses; j++){                                         \
+            runningTime += t[j];                                                               \
+            procWait = PREFIX##Wait(p[j], t[j], start);                                        \
+            if(PREFIX##ProcessWaits)                                                           \
+                processWaitingTime += procWait;                                                \
+            if(verbose)                                                                        \
+                PREFIX##Report(p[j], t[j]);                                                    \
+            if(record)                                                                         \
+                appendResult(#NAME, i, tickStart + procWait, p[j], PREFIX##Estimate(p[j]),     \
+                             t[j], procWait);                                                  \
+            if(histogramOut != NULL){                                                          \
+                recordValue(&waitHistograms[p[j]], procWait);                                  \
+                if(!PREFIX##ChainedStarts)                                                     \
+                    recordValue(&turnAroundHistogram, procWait + t[j]);                        \
+            }                                                                                  \
+            estimate = PREFIX##Estimate(p[j]);                                                 \
+            PREFIX##Update(p[j], t[j]);                                                        \
+            if(tracing)                                                                        \
+                traceEvent(ID, i, processes[p[j]].processID, estimate, t[j],                   \
+                           PREFIX##Estimate(p[j]));                                            \
+            start += t[j];                                                                     \
+        }                                                                                      \
+        if(histogramOut != NULL && PREFIX##ChainedStarts)                                      \
+            recordValue(&turnAroundHistogram, start);                                          \
+        waitingTime += t[0];                                                                   \
+        turnAroundTime = runningTime + waitingTime;                                            \
+    }                                                                                          \
+    if(resultsFd >= 0)                                                                         \
+        flushResults();                                                                        \
+    if(!quiet){                                                                                \
+        printf("Turnaround time: %d\n", turnAroundTime);                                       \
+        printf("Waiting time: %d\n", waitingTime);                                             \
+        if(PREFIX##ProcessWaits)                                                               \
+            printf("Process waiting time: %ld\n", processWaitingTime);                         \
+        if(STATEFUL)                                                                           \
+            printf("Estimation Error: %d\n", error);                                           \
+        if(histogramOut != NULL)                                                               \
+            reportHistograms(#NAME, PREFIX##ChainedStarts ? (long)(to - from) : 0);            \
+    }                                                                                          \
+    lastTurnAroundTime = turnAroundTime;                                                       \
+    lastWaitingTime = waitingTime;                                                             \
+    lastError = error;                                                                         \
+    runningTime = 0;                                                                           \
+    turnAroundTime = 0;                                                                        \
+    waitingTime = 0;                                                                           \
+    error = 0;                                                                                 \
+}
+
+/**
+* Policy traits shared by the non-preemptive policies
+* @param t is the burst of each process in load order
+*/
+static inline void noPrepare(int* t){
+    (void)t;
+}
+
+/**
+* Gives the waiting time of a process that runs to completion once started
+* @param j is the index of the process
+* @param t is its burst this tick
+* @param start is the time it started, relative to the start of the tick
+* @return the waiting time
+*/
+static inline int startWait(int j, int t, int start){
+    (void)j;
+    (void)t;
+    return start;
+}
+
+/**
+* Gives the estimate of a policy that does not predict bursts
+* @param j is the index of the process
+* @return -1
+*/
+static inline int noEstimate(int j){
+    (void)j;
+    return -1;
+}
+
+/**
+* Prints a process that has no estimate
+* @param j is the index of the process
+* @param t is its burst this tick
 */
-void printSJF(){
+static inline void burstReport(int j, int t){
+    printf("  Process %d took %d.\n", processes[j].processID, t);
+}
+
+/**
+* Leaves a stateless process unchanged
+* @param j is the index of the process
+* @param t is its burst this tick
+*/
+static inline void noUpdate(int j, int t){
+    (void)j;
+    (void)t;
+}
+
+/**
+* SJF runs the shortest actual burst first
+*/
+#define sjfPrepare noPrepare
+#define sjfWait startWait
+#define sjfEstimate noEstimate
+#define sjfProcessWaits 0
+#define sjfChainedStarts 1
+#define sjfReport burstReport
+#define sjfUpdate noUpdate
+static inline int sjfKey(int j, int t){
+    (void)j;
+    return t;
+}
+
+static inline int nextTau(int tau, int t, float alpha);
+
+/**
+* SJFL runs the shortest estimate first and then moves tau towards the
+* actual burst by alpha
+*/
+#define sjflPrepare noPrepare
+#define sjflWait startWait
+#define sjflProcessWaits 0
+#define sjflChainedStarts 1
+static inline int sjflKey(int j, int t){
+    (void)t;
+    return processes[j].tau;
+}
+
+static inline int sjflEstimate(int j){
+    return processes[j].tau;
+}
+
+static inline void sjflReport(int j, int t){
+    printf("  Process %d was estimated for %d and took %d.\n", processes[j].processID, processes[j].tau, t);
+}
+
+static inline void sjflUpdate(int j, int t){
+    int diff = abs((int)((float)processes[j].tau - (float)t));
+    error += diff;
+    if(histogramOut != NULL)
+        recordValue(&errorHistogram, diff);
+    processes[j].tau = nextTau(processes[j].tau, t, processes[j].alpha);
+}
+
+/**
+* Moves an estimate towards the actual burst by alpha
+* @param tau is the current estimate
+* @param t is the actual burst
+* @param alpha is the smoothing factor
+* @return the next estimate
+*/
+static inline int nextTau(int tau, int t, float alpha){
+    float diff = ((float)tau - (float)t) * alpha;
+    if(diff < 0)
+        return tau - (int)diff;
+    return tau - abs((int)round((double)diff));
+}
+
+/**
+* Priority runs the lowest process ID first
+*/
+#define priorityPrepare noPrepare
+#define priorityWait startWait
+#define priorityEstimate noEstimate
+#define priorityProcessWaits 1
+#define priorityChainedStarts 1
+#define priorityReport burstReport
+#define priorityUpdate noUpdate
+static inline int priorityKey(int j, int t){
+    (void)t;
+    return processes[j].processID;
+}
+
+/**
+* Round robin hands out quantum-sized slices in load order. Processes are
+* listed in the order they finish, which is what rrPrepare() works out.
+* @param t is the burst of each process in load order
+*/
+static inline void rrPrepare(int* t){
+    int j, slice, left = numProcesses, clock = 0;
+    for(j = 0; j < numProcesses; j++)
+        rrRemaining[j] = t[j];
+    while(left > 0){
+        for(j = 0; j < numProcesses; j++){
+            if(rrRemaining[j] < 0)
+                continue;
+            slice = rrRemaining[j] < quantum ? rrRemaining[j] : quantum;
+            clock += slice;
+            rrRemaining[j] -= slice;
+            if(rrRemaining[j] == 0){
+                rrDone[j] = clock;
+                rrRemaining[j] = -1;
+                left--;
+            }
+        }
+    }
+}
+
+#define rrEstimate noEstimate
+#define rrProcessWaits 1
+#define rrChainedStarts 0
+#define rrReport burstReport
+#define rrUpdate noUpdate
+static inline int rrKey(int j, int t){
+    (void)t;
+    return rrDone[j];
+}
+
+static inline int rrWait(int j, int t, int start){
+    (void)start;
+    return rrDone[j] - t;
+}
+
+DEFINE_TICK_ENGINE(SJF, sjf, POLICY_SJF, 0)
+DEFINE_TICK_ENGINE(SJFL, sjfl, POLICY_SJFL, 1)
+DEFINE_TICK_ENGINE(Priority, priority, POLICY_PRIORITY, 0)
+DEFINE_TICK_ENGINE(RoundRobin, rr, POLICY_RR, 0)
+
+/**
+* Hand-written SJF loop the engine was factored out of, kept as the
+* reference for benchmarks
+*/
+void referenceSJF(){
     int i, j;
     int p[numProcesses], t[numProcesses];
-    printf("==Shortest-Job-First==\n");
     for(i = 0; i < numTicks; i++) {
-        printf("Simulating %dth tick of processes @ time %d:\n", i, runningTime);
         for (j = 0; j < numProcesses; j++) {
-            p[j] = processes[j].processID;
+            p[j] = j;
             t[j] = processes[j].t[i];
         }
         SJFSort(p, t, numProcesses);
-        for (j = 0; j < numProcesses; j++){
-            runningTime += processes[j].t[i];
-            printf("  Process %d took %d.\n", p[j], t[j]);
-        }
+        for (j = 0; j < numProcesses; j++)
+            runningTime += t[j];
         waitingTime += t[0];
         turnAroundTime = runningTime + waitingTime;
     }
-    printf("Turnaround time: %d\n", turnAroundTime);
-    printf("Waiting time: %d\n", waitingTime);
+    lastTurnAroundTime = turnAroundTime;
+    lastWaitingTime = waitingTime;
+    lastError = 0;
     runningTime = 0;
     turnAroundTime = 0;
     waitingTime = 0;
 }
 
 /**
-* Prints SJFL data to console
+* Hand-written SJFL loop the engine was factored out of, kept as the
+* reference for benchmarks
 */
-void printSJFL(){
+void referenceSJFL(){
     int i, j, tau[numProcesses];
     float diff;
     int p[numProcesses], t[numProcesses];
-    printf("==Shortest-Job-First Live==\n");
     for(i = 0; i < numTicks; i++) {
-        printf("Simulating %dth tick of processes @ time %d:\n", i, runningTime);
         for (j = 0; j < numProcesses; j++) {
-            p[j] = processes[j].processID;
+            p[j] = j;
             t[j] = processes[j].t[i];
             tau[j] = processes[j].tau;
         }
         SJFLSort(p, t, tau, numProcesses);
         for (j = 0; j < numProcesses; j++){
-            runningTime += processes[j].t[i];
-            printf("  Process %d was estimated for %d and took %d.\n", p[j], processes[p[j]].tau, t[j]);
+            runningTime += t[j];
             diff = (float)processes[p[j]].tau - (float)t[j];
             error += abs((int)diff);
             diff = diff * processes[p[j]].alpha;
@@ -130,18 +1005,1159 @@ void printSJFL(){
         waitingTime += t[0];
         turnAroundTime = runningTime + waitingTime;
     }
-    printf("Turnaround time: %d\n", turnAroundTime);
-    printf("Waiting time: %d\n", waitingTime);
-    printf("Estimation Error: %d\n", error);
+    lastTurnAroundTime = turnAroundTime;
+    lastWaitingTime = waitingTime;
+    lastError = error;
     runningTime = 0;
     turnAroundTime = 0;
     waitingTime = 0;
     error = 0;
 }
 
+/**
+* Times every engine against the hand-written loops with output off and
+* reports nanoseconds per process-tick. tau is restored before each run.
+* An engine fails if its totals differ from the reference loop it
+* replaces, if it is slower than --max-ns, or if it takes more than
+* --max-ratio times as long as that reference loop did in the same run.
+* @param repeats is the number of runs per kernel
+* @return the number of failed kernels
+*/
+int runBenchmark(int repeats){
+    int k, r, j, failures = 0, reference[3] = {0, 0, 0}, initialTau[numProcesses];
+    double nanoseconds, referenceNanoseconds = 0.0;
+    double seconds;
+    struct timespec begin, end;
+    struct { const char* name; void (*run)(); int role; } kernels[] = {
+        {"reference SJF", referenceSJF, 1},
+        {"engine SJF", printSJF, 2},
+        {"reference SJFL", referenceSJFL, 1},
+        {"engine SJFL", printSJFL, 2},
+        {"engine Priority", printPriority, 0},
+        {"engine RoundRobin", printRoundRobin, 0}
+    };
+    for(j = 0; j < numProcesses; j++)
+        initialTau[j] = processes[j].tau;
+    quiet = 1;
+    for(k = 0; k < (int)(sizeof(kernels) / sizeof(kernels[0])); k++){
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for(r = 0; r < repeats; r++){
+            for(j = 0; j < numProcesses; j++)
+                processes[j].tau = initialTau[j];
+            kernels[k].run();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds = (double)(end.tv_sec - begin.tv_sec) + (double)(end.tv_nsec - begin.tv_nsec) / 1e9;
+        nanoseconds = seconds * 1e9 / ((double)repeats * numTicks * numProcesses);
+        printf("%-18s %10.2f ns/process-tick  (turnaround %d, waiting %d, error %d)\n", kernels[k].name,
+               nanoseconds, lastTurnAroundTime, lastWaitingTime, lastError);
+        if(kernels[k].role == 1){
+            referenceNanoseconds = nanoseconds;
+            reference[0] = lastTurnAroundTime;
+            reference[1] = lastWaitingTime;
+            reference[2] = lastError;
+        } else if(kernels[k].role == 2 && (lastTurnAroundTime != reference[0]
+                  || lastWaitingTime != reference[1] || lastError != reference[2])){
+            printf("  FAIL: totals differ from the reference loop\n");
+            failures++;
+        }
+        if(kernels[k].role != 1 && maxNanoseconds > 0 && nanoseconds > maxNanoseconds){
+            printf("  FAIL: slower than %.2f ns/process-tick\n", maxNanoseconds);
+            failures++;
+        }
+        if(kernels[k].role == 2 && maxRatio > 0 && nanoseconds > maxRatio * referenceNanoseconds){
+            printf("  FAIL: more than %.2f times the reference loop\n", maxRatio);
+            failures++;
+        }
+    }
+    quiet = 0;
+    return failures;
+}
+
+/**
+* Reshapes a generated trace into one of the edge cases the engines must
+* agree with the reference loops on
+* @param kind selects the case: 0 leaves the trace random, 1 makes every
+* burst and estimate tie, 2 zeroes every third burst, 3 and 4 pin alpha
+* to 0 and 1, 5 keeps a single process
+*/
+void shapeEdgeCase(int kind){
+    int i, j;
+    for(j = 0; j < numProcesses; j++){
+        for(i = 0; i < numTicks; i++){
+            if(kind == 1)
+                processes[j].t[i] = processes[0].t[i];
+            else if(kind == 2 && (i + j) % 3 == 0)
+                processes[j].t[i] = 0;
+        }
+        if(kind == 1)
+            processes[j].tau = processes[0].tau;
+        else if(kind == 3)
+            processes[j].alpha = 0.0f;
+        else if(kind == 4)
+            processes[j].alpha = 1.0f;
+    }
+    if(kind == 5)
+        numProcesses = 1;
+}
+
+/**
+* Runs the SJF and SJFL engines against the hand-written reference loops
+* on generated traces and edge cases, comparing totals and the final tau
+* of every process
+* @param traces is the number of traces to check
+* @return the number of traces on which they disagree
+*/
+int runVerify(long traces){
+    int j, failures = 0, maxProcesses = 16;
+    int initialTau[maxProcesses], referenceTau[maxProcesses];
+    int reference[3];
+    long s;
+    numTicks = 64;
+    lastTick = numTicks;
+    processes = (Process*)malloc(maxProcesses * sizeof(Process));
+    for(j = 0; j < maxProcesses; j++){
+        processes[j].t = (int*)malloc(sizeof(int) * numTicks);
+        processes[j].marks = NULL;
+    }
+    quiet = 1;
+    for(s = 0; s < traces; s++){
+        numProcesses = 1 + (int)(s % maxProcesses);
+        generateScenario(s);
+        shapeEdgeCase((int)(s % 6));
+        for(j = 0; j < numProcesses; j++)
+            initialTau[j] = processes[j].tau;
+        referenceSJF();
+        reference[0] = lastTurnAroundTime;
+        reference[1] = lastWaitingTime;
+        printSJF();
+        if(lastTurnAroundTime != reference[0] || lastWaitingTime != reference[1]){
+            printf("Trace %ld: SJF engine gave %d/%d, reference %d/%d\n", s,
+                   lastTurnAroundTime, lastWaitingTime, reference[0], reference[1]);
+            failures++;
+        }
+        referenceSJFL();
+        reference[0] = lastTurnAroundTime;
+        reference[1] = lastWaitingTime;
+        reference[2] = lastError;
+        for(j = 0; j < numProcesses; j++){
+            referenceTau[j] = processes[j].tau;
+            processes[j].tau = initialTau[j];
+        }
+        printSJFL();
+        for(j = 0; j < numProcesses && processes[j].tau == referenceTau[j]; j++)
+            ;
+        if(lastTurnAroundTime != reference[0] || lastWaitingTime != reference[1]
+           || lastError != reference[2] || j < numProcesses){
+            printf("Trace %ld: SJFL engine gave %d/%d/%d, reference %d/%d/%d%s\n", s,
+                   lastTurnAroundTime, lastWaitingTime, lastError, reference[0], reference[1], reference[2],
+                   j < numProcesses ? ", final tau differs" : "");
+            failures++;
+        }
+        failures += verifySweep(s, initialTau);
+    }
+    quiet = 0;
+    numProcesses = maxProcesses;
+    printf("%ld traces checked, %d mismatches\n", traces, failures);
+    return failures;
+}
+
+/**
+* Lays a trace out tick by tick so a block of ticks is one contiguous
+* run of memory
+* @param rows holds the bursts process by process
+* @param n is the number of processes
+* @param ticks is the number of ticks
+* @return the bursts, n per tick
+*/
+int* transposeBursts(Process* rows, int n, int ticks){
+    int i, j;
+    int* bursts = (int*)malloc((size_t)n * ticks * sizeof(int));
+    for(j = 0; j < n; j++)
+        for(i = 0; i < ticks; i++)
+            bursts[(size_t)i * n + j] = rows[j].t[i];
+    return bursts;
+}
+
+/**
+* Runs SJFL over one trace for every alpha at once. Ticks are taken in
+* blocks small enough to stay in L2, and each block is run through every
+* configuration before moving on, so the trace streams from memory once
+* rather than once per alpha.
+* @param trace is the trace; its rows are read through bursts
+* @param bursts holds the trace n per tick, as from transposeBursts()
+* @param totals receives one result per alpha
+*/
+void sweepTrace(const SweepTrace* trace, const int* bursts, SweepTotals* totals){
+    int c, i, j, i0, end, n = trace->numProcesses, blockTicks = SWEEP_BLOCK_BYTES / (n * (int)sizeof(int));
+    int p[n], t[n], key[n];
+    int* taus = (int*)malloc((size_t)numAlphas * n * sizeof(int));
+    int* tau;
+    const int* row;
+    float diff;
+    if(blockTicks < 1)
+        blockTicks = 1;
+    for(c = 0; c < numAlphas; c++){
+        for(j = 0; j < n; j++)
+            taus[c * n + j] = trace->rows[j].tau;
+        totals[c].runningTime = 0;
+        totals[c].waitingTime = 0;
+        totals[c].error = 0;
+    }
+    for(i0 = 0; i0 < trace->numTicks; i0 += blockTicks){
+        end = i0 + blockTicks < trace->numTicks ? i0 + blockTicks : trace->numTicks;
+        for(c = 0; c < numAlphas; c++){
+            tau = taus + c * n;
+            for(i = i0; i < end; i++){
+                row = bursts + (size_t)i * n;
+                for(j = 0; j < n; j++){
+                    p[j] = j;
+                    t[j] = row[j];
+                    key[j] = tau[j];
+                }
+                SJFLSort(p, t, key, n);
+                for(j = 0; j < n; j++){
+                    totals[c].runningTime += t[j];
+                    diff = (float)tau[p[j]] - (float)t[j];
+                    totals[c].error += abs((int)diff);
+                    tau[p[j]] = nextTau(tau[p[j]], t[j], alphas[c]);
+                }
+                totals[c].waitingTime += t[0];
+            }
+        }
+    }
+    free(taus);
+}
+
+/**
+* Orders the CPUs this process may run on so that consecutive workers
+* land on different NUMA nodes: the first allowed CPU of each node, then
+* the second of each, and so on. CPUs the node lists do not mention are
+* treated as node 0, so without sysfs this is just the allowed set.
+*/
+void planPlacement(){
+    cpu_set_t allowed;
+    int cpu, node, first, last, nodes = 1, picked = 1;
+    int* nodeOf = (int*)calloc(CPU_SETSIZE, sizeof(int));
+    char path[64];
+    FILE* list;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(cpu_set_t), &allowed);
+    for(node = 0; node < MAX_NODES; node++){
+        sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+        list = fopen(path, "r");
+        if(list == NULL)
+            continue;
+        while(fscanf(list, "%d", &first) == 1){
+            if(fscanf(list, "-%d", &last) != 1)
+                last = first;
+            for(cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+                nodeOf[cpu] = node;
+            fgetc(list);
+        }
+        fclose(list);
+        nodes = node + 1;
+    }
+    sweepCpus = (int*)malloc(CPU_SETSIZE * sizeof(int));
+    numSweepCpus = 0;
+    while(picked){
+        picked = 0;
+        for(node = 0; node < nodes; node++){
+            for(cpu = 0; cpu < CPU_SETSIZE; cpu++){
+                if(CPU_ISSET(cpu, &allowed) && nodeOf[cpu] == node){
+                    CPU_CLR(cpu, &allowed);
+                    sweepCpus[numSweepCpus++] = cpu;
+                    picked = 1;
+                    break;
+                }
+            }
+        }
+    }
+    free(nodeOf);
+}
+
+/**
+* Sweeps the traces assigned to one worker. With --numa the worker is
+* pinned to its CPU from planPlacement() first and makes its own copy of
+* each trace, so the pages it reads are allocated on its node.
+* @param arg is the worker number
+* @return NULL
+*/
+void* sweepWorker(void* arg){
+    int k, w = (int)(long)arg;
+    int* bursts;
+    cpu_set_t cpus;
+    if(numSweepCpus > 0){
+        CPU_ZERO(&cpus);
+        CPU_SET(sweepCpus[w % numSweepCpus], &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+    }
+    for(k = w; k < numSweepTraces; k += mcWorkers){
+        bursts = transposeBursts(sweepTraces[k].rows, sweepTraces[k].numProcesses, sweepTraces[k].numTicks);
+        sweepTrace(&sweepTraces[k], bursts, sweepTotals + (size_t)k * numAlphas);
+        free(bursts);
+    }
+    return NULL;
+}
+
+/**
+* Loads every trace, evaluates every alpha on each in parallel and
+* reports the totals with the throughput achieved
+* @param count is the number of data files
+* @param files are the data file names
+*/
+void runSweep(int count, char** files){
+    int k, c, j;
+    long long bursts = 0, bytes = 0;
+    double seconds;
+    struct timespec begin, end;
+    pthread_t* workers;
+    sweepTraces = (SweepTrace*)malloc(count * sizeof(SweepTrace));
+    for(k = 0; k < count; k++){
+        if(access(files[k], F_OK) == -1){
+            printf("Data file %s does not exist.\n", files[k]);
+            exit(1);
+        }
+        readFile(files[k]);
+        sweepTraces[k].name = files[k];
+        sweepTraces[k].numTicks = numTicks;
+        sweepTraces[k].numProcesses = numProcesses;
+        sweepTraces[k].rows = processes;
+        bursts += (long long)numTicks * numProcesses * numAlphas;
+        bytes += (long long)numTicks * numProcesses * (long long)sizeof(int);
+        processes = NULL;
+    }
+    numSweepTraces = count;
+    numProcesses = 0;
+    if(mcWorkers < 1)
+        mcWorkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    sweepTotals = (SweepTotals*)malloc((size_t)count * numAlphas * sizeof(SweepTotals));
+    workers = (pthread_t*)malloc(mcWorkers * sizeof(pthread_t));
+    if(numaPlacement)
+        planPlacement();
+    printf("Alpha sweep: %d traces x %d alphas on %d workers%s\n\n", count, numAlphas, mcWorkers,
+           numaPlacement ? ", pinned" : "");
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for(k = 0; k < mcWorkers; k++)
+        pthread_create(&workers[k], NULL, sweepWorker, (void*)(long)k);
+    for(k = 0; k < mcWorkers; k++)
+        pthread_join(workers[k], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (double)(end.tv_sec - begin.tv_sec) + (double)(end.tv_nsec - begin.tv_nsec) / 1e9;
+    for(k = 0; k < count; k++){
+        for(c = 0; c < numAlphas; c++)
+            printf("%s alpha %.3f: turnaround %d, waiting %d, error %d\n", sweepTraces[k].name, alphas[c],
+                   sweepTotals[k * numAlphas + c].runningTime + sweepTotals[k * numAlphas + c].waitingTime,
+                   sweepTotals[k * numAlphas + c].waitingTime, sweepTotals[k * numAlphas + c].error);
+        for(j = 0; j < sweepTraces[k].numProcesses; j++)
+            free(sweepTraces[k].rows[j].t);
+        free(sweepTraces[k].rows);
+    }
+    printf("\n%lld bursts in %.3f s: %.0f bursts/s, %.1f MB/s read, %.1f MB/s effective\n", bursts, seconds,
+           (double)bursts / seconds, (double)bytes / seconds / 1e6,
+           (double)bursts * sizeof(int) / seconds / 1e6);
+    free(workers);
+    free(sweepCpus);
+    free(sweepTotals);
+    free(sweepTraces);
+}
+
+/**
+* Checks the blocked alpha sweep against the SJFL engine on one trace,
+* with every process given alpha 0.5 and then the first process's alpha
+* @param s is the trace number
+* @param initialTau holds each process's starting estimate
+* @return 1 if they disagree, otherwise 0
+*/
+int verifySweep(long s, int* initialTau){
+    int c, j, failed = 0, saved = numAlphas;
+    float savedAlphas[2], savedAlpha[numProcesses];
+    SweepTrace trace = {"verify", numTicks, numProcesses, processes};
+    SweepTotals totals[2];
+    int* bursts = transposeBursts(processes, numProcesses, numTicks);
+    memcpy(savedAlphas, alphas, sizeof(savedAlphas));
+    alphas[0] = 0.5f;
+    alphas[1] = processes[0].alpha;
+    numAlphas = 2;
+    for(j = 0; j < numProcesses; j++){
+        savedAlpha[j] = processes[j].alpha;
+        processes[j].tau = initialTau[j];
+    }
+    sweepTrace(&trace, bursts, totals);
+    for(c = 0; c < 2; c++){
+        for(j = 0; j < numProcesses; j++){
+            processes[j].tau = initialTau[j];
+            processes[j].alpha = alphas[c];
+        }
+        printSJFL();
+        if(lastTurnAroundTime != totals[c].runningTime + totals[c].waitingTime
+           || lastWaitingTime != totals[c].waitingTime || lastError != totals[c].error){
+            printf("Trace %ld: alpha sweep at %.3f gave %d/%d/%d, engine %d/%d/%d\n", s, alphas[c],
+                   totals[c].runningTime + totals[c].waitingTime, totals[c].waitingTime, totals[c].error,
+                   lastTurnAroundTime, lastWaitingTime, lastError);
+            failed = 1;
+        }
+    }
+    for(j = 0; j < numProcesses; j++)
+        processes[j].alpha = savedAlpha[j];
+    memcpy(alphas, savedAlphas, sizeof(savedAlphas));
+    numAlphas = saved;
+    free(bursts);
+    return failed;
+}
+
+/**
+* Draws a uniform number for one (scenario, stream, counter) triple.
+* The value depends only on those and the seed, never on which worker
+* asks for it, so results are the same for any number of workers.
+* @param scenario is the scenario number
+* @param stream is the process index, or -1 for per-scenario draws
+* @param counter is the position within the stream
+* @return a value in [0, 1)
+*/
+double counterRandom(long scenario, int stream, long counter){
+    unsigned long long x = mcSeed;
+    x ^= mix64((unsigned long long)scenario * 0x9E3779B97F4A7C15ull);
+    x ^= mix64((unsigned long long)(stream + 1) * 0xC2B2AE3D27D4EB4Full + (unsigned long long)counter);
+    return (double)(mix64(x) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+* SplitMix64 finalizer
+* @param x is the value to scramble
+* @return the scrambled value
+*/
+unsigned long long mix64(unsigned long long x){
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+* Draws one burst from the configured distribution
+* @param u is a uniform value in [0, 1)
+* @param v is a second uniform value, used by the bimodal distribution
+* @return the burst
+*/
+int drawBurst(double u, double v){
+    double mean = mcParams[0];
+    switch(mcDistribution){
+        case MC_UNIFORM:
+            return (int)mcParams[0] + (int)(u * (mcParams[1] - mcParams[0] + 1));
+        case MC_BIMODAL:
+            mean = v < mcParams[2] ? mcParams[0] : mcParams[1];
+            /* fall through */
+        default:
+            return (int)round(-mean * log(1.0 - u));
+    }
+}
+
+/**
+* Fills processes with one generated scenario
+* @param scenario is the scenario number
+*/
+void generateScenario(long scenario){
+    int i, j;
+    for(j = 0; j < numProcesses; j++){
+        processes[j].processID = j;
+        processes[j].alpha = (float)counterRandom(scenario, -1, 2L * j);
+        processes[j].tau = drawBurst(counterRandom(scenario, -1, 2L * j + 1), counterRandom(scenario, j, -1));
+        for(i = 0; i < numTicks; i++)
+            processes[j].t[i] = drawBurst(counterRandom(scenario, j, 2L * i), counterRandom(scenario, j, 2L * i + 1));
+    }
+}
+
+/**
+* Allocates a trace of the given shape and fills it with scenario 0, for
+* benchmarking without a data file
+* @param shape is "processes:ticks"
+*/
+void generateTrace(const char* shape){
+    int j;
+    if(sscanf(shape, "%d:%d", &numProcesses, &numTicks) != 2 || numProcesses < 1 || numTicks < 1){
+        printf("Trace shape must be given as PROCESSES:TICKS.\n");
+        exit(1);
+    }
+    lastTick = numTicks;
+    processes = (Process*)malloc(numProcesses * sizeof(Process));
+    for(j = 0; j < numProcesses; j++){
+        processes[j].t = (int*)malloc(sizeof(int) * numTicks);
+        processes[j].marks = NULL;
+    }
+    generateScenario(0);
+}
+
+/**
+* Runs SJF and SJFL over generated scenarios on every core and prints
+* 95% confidence intervals for how SJFL compares with SJF. Workers are
+* forked so each has its own copy of the simulation state, and write
+* their results into a shared array indexed by scenario; the totals are
+* then summed in scenario order, so they do not depend on the worker count.
+* A worker that crashes or exits non-zero leaves its scenarios unfilled,
+* so no intervals are reported if any worker failed.
+* @param shape is "processes:ticks"
+*/
+void runMonteCarlo(const char* shape){
+    int w, j, status, failed = 0;
+    long s;
+    pid_t pid;
+    MonteCarloResult* results;
+    if(sscanf(shape, "%d:%d", &numProcesses, &numTicks) != 2 || numProcesses < 1 || numTicks < 1){
+        printf("Monte Carlo shape must be given as PROCESSES:TICKS.\n");
+        exit(1);
+    }
+    if(mcWorkers < 1)
+        mcWorkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    results = (MonteCarloResult*)mmap(NULL, mcScenarios * sizeof(MonteCarloResult), PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(results == MAP_FAILED){
+        printf("Cannot allocate Monte Carlo results.\n");
+        exit(1);
+    }
+    printf("Monte Carlo: %ld scenarios of %d processes x %d ticks on %d workers\n\n",
+           mcScenarios, numProcesses, numTicks, mcWorkers);
+    fflush(stdout);
+    for(w = 0; w < mcWorkers; w++){
+        pid = fork();
+        if(pid < 0){
+            printf("Cannot start Monte Carlo worker.\n");
+            exit(1);
+        }
+        if(pid > 0)
+            continue;
+        processes = (Process*)malloc(numProcesses * sizeof(Process));
+        for(j = 0; j < numProcesses; j++){
+            processes[j].t = (int*)malloc(sizeof(int) * numTicks);
+            processes[j].marks = NULL;
+        }
+        lastTick = numTicks;
+        quiet = 1;
+        for(s = w; s < mcScenarios; s += mcWorkers){
+            generateScenario(s);
+            printSJF();
+            results[s].waitDiff = -(double)lastWaitingTime;
+            results[s].turnAroundDiff = -(double)lastTurnAroundTime;
+            printSJFL();
+            results[s].waitDiff += (double)lastWaitingTime;
+            results[s].turnAroundDiff += (double)lastTurnAroundTime;
+            results[s].error = (double)lastError / ((double)numProcesses * numTicks);
+        }
+        _exit(0);
+    }
+    while(waitpid(-1, &status, 0) > 0){
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            failed++;
+    }
+    if(failed > 0){
+        printf("%d Monte Carlo worker%s failed; no intervals reported.\n", failed, failed == 1 ? "" : "s");
+        munmap(results, mcScenarios * sizeof(MonteCarloResult));
+        exit(1);
+    }
+    reportInterval("Waiting time, SJFL - SJF", results, offsetof(MonteCarloResult, waitDiff));
+    reportInterval("Turnaround time, SJFL - SJF", results, offsetof(MonteCarloResult, turnAroundDiff));
+    reportInterval("SJFL estimation error per burst", results, offsetof(MonteCarloResult, error));
+    munmap(results, mcScenarios * sizeof(MonteCarloResult));
+    numProcesses = 0;
+}
+
+/**
+* Prints the mean of one result field with its 95% confidence interval
+* @param label describes the field
+* @param results holds one result per scenario
+* @param field is the offset of the field within MonteCarloResult
+*/
+void reportInterval(const char* label, MonteCarloResult* results, size_t field){
+    long s;
+    double value, mean = 0.0, m2 = 0.0, delta, half;
+    for(s = 0; s < mcScenarios; s++){
+        value = *(double*)((char*)&results[s] + field);
+        delta = value - mean;
+        mean += delta / (double)(s + 1);
+        m2 += delta * (value - mean);
+    }
+    half = mcScenarios > 1 ? 1.96 * sqrt(m2 / (double)(mcScenarios - 1) / (double)mcScenarios) : 0.0;
+    printf("%s: mean %.4f, 95%% CI [%.4f, %.4f]\n", label, mean, mean - half, mean + half);
+}
+
+/**
+* Gives the size of a snapshot: a header followed by one entry per process
+* @return the size in bytes
+*/
+size_t snapshotSize(){
+    return sizeof(SnapshotHeader) + numProcesses * sizeof(SnapshotEntry);
+}
+
+/**
+* Starts the background thread that writes checkpoints to disk
+*/
+void startCheckpoints(){
+    stagedSnapshot = (SnapshotHeader*)malloc(snapshotSize());
+    pthread_create(&checkpointThread, NULL, checkpointWriter, NULL);
+}
+
+/**
+* Captures SJFL state at a tick boundary
+* @param snapshot is a buffer of snapshotSize() bytes
+* @param tick is the next tick to be simulated; it must be a multiple of markEvery
+*/
+void fillSnapshot(SnapshotHeader* snapshot, int tick){
+    int j;
+    SnapshotEntry* entries = (SnapshotEntry*)(snapshot + 1);
+    memcpy(snapshot->magic, "SJFLCKP2", 8);
+    snapshot->dataSize = dataSize;
+    snapshot->dataModified = dataModified;
+    snapshot->numTicks = numTicks;
+    snapshot->numProcesses = numProcesses;
+    snapshot->tick = tick;
+    snapshot->runningTime = runningTime;
+    snapshot->waitingTime = waitingTime;
+    snapshot->error = error;
+    for(j = 0; j < numProcesses; j++){
+        entries[j].processID = processes[j].processID;
+        entries[j].tau = processes[j].tau;
+        entries[j].alpha = processes[j].alpha;
+        entries[j].offset = processes[j].marks[tick / markEvery];
+    }
+}
+
+/**
+* Opens the tick index for writing and silences per-tick output while
+* the trace is simulated once to fill it
+*/
+void startIndex(){
+    indexOut = fopen(indexFile, "wb");
+    if(indexOut == NULL){
+        printf("Cannot open index file %s.\n", indexFile);
+        terminate(1);
+    }
+    indexSnapshot = (SnapshotHeader*)malloc(snapshotSize());
+    printFrom = numTicks;
+}
+
+/**
+* Closes the tick index
+*/
+void stopIndex(){
+    if(fclose(indexOut) != 0)
+        failIndex();
+    free(indexSnapshot);
+    indexOut = NULL;
+    indexSnapshot = NULL;
+    printf("Tick index written to %s\n", indexFile);
+}
+
+/**
+* Appends a snapshot to the tick index being built
+* @param tick is the next tick to be simulated
+*/
+void appendIndex(int tick){
+    fillSnapshot(indexSnapshot, tick);
+    if(fwrite(indexSnapshot, snapshotSize(), 1, indexOut) != 1)
+        failIndex();
+}
+
+/**
+* Reports a failed index write and removes the partial index, which
+* would otherwise pass for a complete one
+*/
+void failIndex(){
+    struct stat info;
+    printf("Cannot write index file %s: %s. Run --build-index again.\n", indexFile, strerror(errno));
+    if(lstat(indexFile, &info) == 0 && S_ISREG(info.st_mode))
+        remove(indexFile);
+    terminate(1);
+}
+
+/**
+* Copies SJFL state into the staging buffer and hands it to the writer.
+* A snapshot the writer has not picked up yet is simply replaced.
+* @param tick is the next tick to be simulated
+*/
+void stageCheckpoint(int tick){
+    pthread_mutex_lock(&checkpointLock);
+    fillSnapshot(stagedSnapshot, tick);
+    snapshotPending = 1;
+    pthread_cond_signal(&checkpointReady);
+    pthread_mutex_unlock(&checkpointLock);
+}
+
+/**
+* Writes staged snapshots to a temporary file and renames it over the
+* checkpoint so a crash mid-write never leaves a torn checkpoint. If any
+* step of the write fails the temporary file is removed and the previous
+* checkpoint is kept; the simulation itself carries on.
+* @param arg is unused
+* @return NULL
+*/
+void* checkpointWriter(void* arg){
+    size_t size = snapshotSize();
+    char* buffer = (char*)malloc(size);
+    char* tmpname = (char*)malloc(strlen(checkpointFile) + 5);
+    FILE* out;
+    int written;
+    sprintf(tmpname, "%s.tmp", checkpointFile);
+    pthread_mutex_lock(&checkpointLock);
+    for(;;){
+        while(!snapshotPending && !checkpointStopping)
+            pthread_cond_wait(&checkpointReady, &checkpointLock);
+        if(!snapshotPending)
+            break;
+        memcpy(buffer, stagedSnapshot, size);
+        snapshotPending = 0;
+        pthread_mutex_unlock(&checkpointLock);
+        out = fopen(tmpname, "wb");
+        written = out != NULL && fwrite(buffer, size, 1, out) == 1 && fflush(out) == 0 && fsync(fileno(out)) == 0;
+        if(out != NULL && fclose(out) != 0)
+            written = 0;
+        if(!written || rename(tmpname, checkpointFile) != 0){
+            printf("Cannot write checkpoint %s: %s. Keeping the previous one.\n", checkpointFile, strerror(errno));
+            remove(tmpname);
+        }
+        pthread_mutex_lock(&checkpointLock);
+    }
+    pthread_mutex_unlock(&checkpointLock);
+    free(tmpname);
+    free(buffer);
+    return arg;
+}
+
+/**
+* Flushes any staged snapshot and stops the writer thread
+*/
+void stopCheckpoints(){
+    pthread_mutex_lock(&checkpointLock);
+    checkpointStopping = 1;
+    pthread_cond_signal(&checkpointReady);
+    pthread_mutex_unlock(&checkpointLock);
+    pthread_join(checkpointThread, NULL);
+    free(stagedSnapshot);
+    stagedSnapshot = NULL;
+}
+
+/**
+* Opens the results sink. Rows are batched into column chunks so output
+* costs one write per RESULT_CHUNK records instead of a printf per record.
+*/
+void startResults(){
+    resultsFd = open(resultsFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(resultsFd < 0){
+        printf("Cannot open results file %s.\n", resultsFile);
+        terminate(1);
+    }
+    memcpy(resultsChunk.magic, "SJFR", 4);
+    resultsChunk.rows = 0;
+    if(resultsCsv)
+        dprintf(resultsFd, "policy,tick,start,pid,estimate,actual,wait\n");
+}
+
+/**
+* Adds one record to the current chunk, flushing it when full
+* @param policy is the name of the policy being simulated
+* @param tick is the tick index
+* @param start is the absolute time the process started
+* @param j is the index of the process
+* @param estimate is the predicted burst, or -1 if the policy has none
+* @param burst is the actual burst
+* @param wait is the time the process waited within the tick
+*/
+void appendResult(const char* policy, int tick, int start, int j, int estimate, int burst, int wait){
+    int row = resultsChunk.rows;
+    if(row > 0 && strncmp(resultsChunk.policy, policy, sizeof(resultsChunk.policy)) != 0){
+        flushResults();
+        row = 0;
+    }
+    if(row == 0){
+        memset(resultsChunk.policy, 0, sizeof(resultsChunk.policy));
+        memcpy(resultsChunk.policy, policy, strnlen(policy, sizeof(resultsChunk.policy)));
+    }
+    resultsChunk.columns[0][row] = tick;
+    resultsChunk.columns[1][row] = start;
+    resultsChunk.columns[2][row] = processes[j].processID;
+    resultsChunk.columns[3][row] = estimate;
+    resultsChunk.columns[4][row] = burst;
+    resultsChunk.columns[5][row] = wait;
+    resultsChunk.rows = row + 1;
+    if(resultsChunk.rows == RESULT_CHUNK)
+        flushResults();
+}
+
+/**
+* Writes the current chunk. The binary layout is the chunk header
+* followed by each column's rows back to back, gathered with one
+* writev(); the CSV fallback formats the chunk into one buffer.
+*/
+void flushResults(){
+    int c, row, rows = resultsChunk.rows;
+    size_t used = 0;
+    char* text;
+    struct iovec parts[RESULT_COLUMNS + 1];
+    if(rows == 0)
+        return;
+    if(resultsCsv){
+        text = (char*)malloc((size_t)rows * 96);
+        for(row = 0; row < rows; row++)
+            used += sprintf(text + used, "%.12s,%d,%d,%d,%d,%d,%d\n", resultsChunk.policy,
+                            resultsChunk.columns[0][row], resultsChunk.columns[1][row],
+                            resultsChunk.columns[2][row], resultsChunk.columns[3][row],
+                            resultsChunk.columns[4][row], resultsChunk.columns[5][row]);
+        parts[0].iov_base = text;
+        parts[0].iov_len = used;
+        writeResults(parts, 1);
+        free(text);
+    } else {
+        parts[0].iov_base = &resultsChunk;
+        parts[0].iov_len = offsetof(ResultsChunk, columns);
+        for(c = 0; c < RESULT_COLUMNS; c++){
+            parts[c + 1].iov_base = resultsChunk.columns[c];
+            parts[c + 1].iov_len = rows * sizeof(int);
+        }
+        writeResults(parts, RESULT_COLUMNS + 1);
+    }
+    resultsChunk.rows = 0;
+}
+
+/**
+* Writes every byte described by a set of buffers, resuming after short
+* writes and interrupted calls
+* @param parts are the buffers, advanced in place as they are written
+* @param count is the number of buffers
+*/
+void writeResults(struct iovec* parts, int count){
+    ssize_t written;
+    while(count > 0){
+        written = writev(resultsFd, parts, count);
+        if(written < 0 && errno == EINTR)
+            continue;
+        if(written < 0){
+            printf("Cannot write results file %s: %s.\n", resultsFile, strerror(errno));
+            terminate(1);
+        }
+        while(count > 0 && (size_t)written >= parts->iov_len){
+            written -= parts->iov_len;
+            parts++;
+            count--;
+        }
+        if(count > 0){
+            parts->iov_base = (char*)parts->iov_base + written;
+            parts->iov_len -= written;
+        }
+    }
+}
+
+/**
+* Opens the event trace and starts the thread that drains the rings
+*/
+void startTrace(){
+    traceOut = fopen(traceFile, "wb");
+    if(traceOut == NULL){
+        printf("Cannot open trace file %s.\n", traceFile);
+        terminate(1);
+    }
+    pthread_create(&traceThread, NULL, traceDrainer, NULL);
+    tracing = 1;
+}
+
+/**
+* Gives the calling thread its own ring, registering it with the drainer
+* @return the ring
+*/
+TraceRing* registerTraceRing(){
+    int k = atomic_fetch_add(&traceRingCount, 1);
+    if(k >= MAX_TRACE_RINGS){
+        printf("Too many tracing threads.\n");
+        exit(1);
+    }
+    localRing = (TraceRing*)calloc(1, sizeof(TraceRing));
+    atomic_store_explicit(&traceRings[k], localRing, memory_order_release);
+    return localRing;
+}
+
+/**
+* Appends one event to the calling thread's ring. Only this thread moves
+* head and only the drainer moves tail, so no lock is needed; the
+* producer waits only if the drainer has fallen a whole ring behind.
+* @param policy is the POLICY_ constant of the engine
+* @param tick is the tick index
+* @param pid is the process ID
+* @param tauBefore is the estimate the process was scheduled with, or -1
+* @param burst is the actual burst
+* @param tauAfter is the estimate after the update, or -1
+*/
+void traceEvent(int policy, int tick, int pid, int tauBefore, int burst, int tauAfter){
+    TraceRing* ring = localRing != NULL ? localRing : registerTraceRing();
+    TraceEvent* event;
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while(head - atomic_load_explicit(&ring->tail, memory_order_acquire) == TRACE_RING_SIZE)
+        sched_yield();
+    event = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    event->policy = policy;
+    event->tick = tick;
+    event->pid = pid;
+    event->tauBefore = tauBefore;
+    event->burst = burst;
+    event->tauAfter = tauAfter;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/**
+* Writes every event published in a ring so far. After a failed write
+* the events are still consumed, so producers never stall, but nothing
+* more is written and the error is kept for stopTrace() to report.
+* @param ring is the ring to drain
+* @return the number of events consumed
+*/
+unsigned long drainRing(TraceRing* ring){
+    unsigned long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    unsigned long count = head - tail, first = tail & (TRACE_RING_SIZE - 1);
+    unsigned long run = count < TRACE_RING_SIZE - first ? count : TRACE_RING_SIZE - first;
+    if(traceWriteError == 0
+       && (fwrite(&ring->events[first], sizeof(TraceEvent), run, traceOut) != run
+           || fwrite(&ring->events[0], sizeof(TraceEvent), count - run, traceOut) != count - run))
+        traceWriteError = errno != 0 ? errno : EIO;
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+    return count;
+}
+
+/**
+* Drains all rings until tracing stops and nothing is left
+* @param arg is unused
+* @return NULL
+*/
+void* traceDrainer(void* arg){
+    int k, stopping;
+    unsigned long drained;
+    TraceRing* ring;
+    for(;;){
+        stopping = atomic_load(&traceStopping);
+        drained = 0;
+        for(k = 0; k < atomic_load(&traceRingCount) && k < MAX_TRACE_RINGS; k++){
+            ring = atomic_load_explicit(&traceRings[k], memory_order_acquire);
+            if(ring != NULL)
+                drained += drainRing(ring);
+        }
+        if(drained == 0){
+            if(stopping)
+                break;
+            usleep(1000);
+        }
+    }
+    return arg;
+}
+
+/**
+* Flushes the rings, stops the drainer and closes the trace. A trace
+* file that could not be written in full is removed rather than left to
+* be replayed as if it were complete.
+*/
+void stopTrace(){
+    int k;
+    struct stat info;
+    tracing = 0;
+    atomic_store(&traceStopping, 1);
+    pthread_join(traceThread, NULL);
+    if(fclose(traceOut) != 0 && traceWriteError == 0)
+        traceWriteError = errno;
+    for(k = 0; k < atomic_load(&traceRingCount) && k < MAX_TRACE_RINGS; k++)
+        free(atomic_load(&traceRings[k]));
+    localRing = NULL;
+    if(traceWriteError != 0){
+        printf("Cannot write trace file %s: %s.\n", traceFile, strerror(traceWriteError));
+        if(lstat(traceFile, &info) == 0 && S_ISREG(info.st_mode))
+            remove(traceFile);
+        terminate(1);
+    }
+}
+
+/**
+* Prints the schedule recorded in a trace in the same form as the tick
+* loops, limited to the --ticks window if one was given. Times count from
+* the first tick in the trace.
+*/
+void replayTrace(){
+    int policy = -1, tick = -1, time = 0, shown;
+    TraceEvent event;
+    FILE* in = fopen(replayFile, "rb");
+    if(in == NULL){
+        printf("Trace %s does not exist.\n", replayFile);
+        exit(1);
+    }
+    while(fread(&event, sizeof(TraceEvent), 1, in) == 1){
+        if(event.policy != policy || event.tick < tick){
+            if(policy != -1)
+                printf("\n");
+            policy = event.policy;
+            tick = -1;
+            time = 0;
+            printf("==%s==\n", policyTitles[policy]);
+        }
+        shown = windowFrom < 0 || (event.tick >= windowFrom && event.tick < windowTo);
+        if(event.tick != tick){
+            tick = event.tick;
+            if(shown)
+                printf("Simulating %dth tick of processes @ time %d:\n", tick, time);
+        }
+        if(shown && event.tauBefore >= 0)
+            printf("  Process %d was estimated for %d and took %d.\n", event.pid, event.tauBefore, event.burst);
+        else if(shown)
+            printf("  Process %d took %d.\n", event.pid, event.burst);
+        time += event.burst;
+    }
+    fclose(in);
+}
+
+/**
+* Opens the histogram dump and allocates one waiting-time histogram per
+* process. The overall waiting distribution is merged from these.
+*/
+void startHistograms(){
+    histogramOut = fopen(histogramFile, "w");
+    if(histogramOut == NULL){
+        printf("Cannot open histogram file %s.\n", histogramFile);
+        terminate(1);
+    }
+    waitHistograms = (Histogram*)calloc(numProcesses, sizeof(Histogram));
+    memset(&turnAroundHistogram, 0, sizeof(Histogram));
+    memset(&errorHistogram, 0, sizeof(Histogram));
+}
+
+/**
+* Finds the bucket for a value. Values below HIST_SUB get exact buckets;
+* above that every power of two is split into HIST_SUB linear buckets,
+* bounding the relative error at 1/HIST_SUB. Treating values below
+* HIST_SUB as if they had exponent HIST_SUB_BITS lets both ranges share
+* one branch-free formula.
+* @param value is a non-negative value; negative values count as 0
+* @return the bucket index
+*/
+static inline int bucketIndex(int value){
+    unsigned int v = value < 0 ? 0u : (unsigned int)value;
+    int e = 31 - __builtin_clz(v | HIST_SUB);
+    return (e - HIST_SUB_BITS) * HIST_SUB + (int)(v >> (e - HIST_SUB_BITS));
+}
+
+/**
+* Gives the largest value that falls into a bucket
+* @param index is the bucket index
+* @return the highest equivalent value
+*/
+int bucketHighest(int index){
+    int e, low;
+    if(index < HIST_SUB)
+        return index;
+    e = index / HIST_SUB + HIST_SUB_BITS - 1;
+    low = (HIST_SUB + index % HIST_SUB) << (e - HIST_SUB_BITS);
+    return low + ((1 << (e - HIST_SUB_BITS)) - 1);
+}
+
+/**
+* Records one value
+* @param h is the histogram
+* @param value is the value to record
+*/
+static inline void recordValue(Histogram* h, int value){
+    h->buckets[bucketIndex(value)]++;
+    h->count++;
+    if(value > h->max)
+        h->max = value;
+}
+
+/**
+* Adds the counts of one histogram into another
+* @param into is the histogram receiving the counts
+* @param from is the histogram being merged
+*/
+void mergeHistogram(Histogram* into, const Histogram* from){
+    int i;
+    for(i = 0; i < HIST_BUCKETS; i++)
+        into->buckets[i] += from->buckets[i];
+    into->count += from->count;
+    if(from->max > into->max)
+        into->max = from->max;
+}
+
+/**
+* Finds the value at a percentile
+* @param h is the histogram
+* @param percentile is in the range 0 to 100
+* @return the highest equivalent value of the bucket holding the percentile
+*/
+int valueAtPercentile(const Histogram* h, double percentile){
+    int i;
+    long long seen = 0, target = (long long)ceil(percentile / 100.0 * (double)h->count);
+    if(target < 1)
+        target = 1;
+    for(i = 0; i < HIST_BUCKETS; i++){
+        seen += h->buckets[i];
+        if(seen >= target)
+            return bucketHighest(i) < h->max ? bucketHighest(i) : h->max;
+    }
+    return h->max;
+}
+
+/**
+* Writes one histogram to the dump: a summary line followed by one
+* "highest-value count" line per non-empty bucket
+* @param label identifies the histogram
+* @param h is the histogram
+*/
+void dumpHistogram(const char* label, const Histogram* h){
+    int i;
+    fprintf(histogramOut, "# %s count %lld max %d p50 %d p99 %d p99.9 %d\n", label, h->count, h->max,
+            valueAtPercentile(h, 50.0), valueAtPercentile(h, 99.0), valueAtPercentile(h, 99.9));
+    for(i = 0; i < HIST_BUCKETS; i++)
+        if(h->buckets[i] != 0)
+            fprintf(histogramOut, "%d %llu\n", bucketHighest(i), h->buckets[i]);
+}
+
+/**
+* Prints overall percentiles, dumps every histogram and clears them for
+* the next policy. For chained policies the turnaround histogram holds
+* only each tick's length; every other turnaround equals the wait of the
+* process that ran next, so the waits are merged in with each tick's
+* leading zero wait taken out.
+* @param policy is the name of the policy that produced the histograms
+* @param chainedTicks is the number of ticks recorded that way, or 0
+*/
+void reportHistograms(const char* policy, long chainedTicks){
+    int j;
+    char label[64];
+    Histogram overall;
+    memset(&overall, 0, sizeof(Histogram));
+    for(j = 0; j < numProcesses; j++)
+        mergeHistogram(&overall, &waitHistograms[j]);
+    if(chainedTicks > 0){
+        mergeHistogram(&turnAroundHistogram, &overall);
+        turnAroundHistogram.buckets[0] -= chainedTicks;
+        turnAroundHistogram.count -= chainedTicks;
+    }
+    printf("Waiting time p50/p99/p99.9: %d/%d/%d\n", valueAtPercentile(&overall, 50.0),
+           valueAtPercentile(&overall, 99.0), valueAtPercentile(&overall, 99.9));
+    sprintf(label, "%s wait", policy);
+    dumpHistogram(label, &overall);
+    sprintf(label, "%s turnaround", policy);
+    dumpHistogram(label, &turnAroundHistogram);
+    if(errorHistogram.count > 0){
+        printf("Estimation error p50/p99/p99.9: %d/%d/%d\n", valueAtPercentile(&errorHistogram, 50.0),
+               valueAtPercentile(&errorHistogram, 99.0), valueAtPercentile(&errorHistogram, 99.9));
+        sprintf(label, "%s error", policy);
+        dumpHistogram(label, &errorHistogram);
+    }
+    for(j = 0; j < numProcesses; j++){
+        sprintf(label, "%s wait pid %d", policy, processes[j].processID);
+        dumpHistogram(label, &waitHistograms[j]);
+    }
+    memset(waitHistograms, 0, numProcesses * sizeof(Histogram));
+    memset(&turnAroundHistogram, 0, sizeof(Histogram));
+    memset(&errorHistogram, 0, sizeof(Histogram));
+}
+
 /**
 * Sorts processes and their respective attributes in SJF algorithm
-* @param p is a pointer to an array of process IDs
+* @param p is a pointer to an array of process indices
 * @param t is a pointer to an array of process t values
 * @param n is the size of the p and t arrays
 */
@@ -159,7 +2175,7 @@ void SJFSort(int *p, int *t, int n){
 
 /**
 * Sorts processes and their respective attributes in SJF algorithm
-* @param p is a pointer to an array of process IDs
+* @param p is a pointer to an array of process indices
 * @param t is a pointer to an array of process t values
 * @param tau is a pointer to an array of process tau values
 * @param n is the size of the p, t and tau arrays
@@ -190,14 +2206,28 @@ void swap(int* x, int* y){
 
 /**
 * Frees memory and exits program
+* @param status is the exit status
 */
-void terminate(){
+void terminate(int status){
     int i;
-    for(i = 0; i < numProcesses; i++)
-        free(processes[i].t);
+    for(i = 0; i < numProcesses; i++){
+        if(mapped == NULL)
+            free(processes[i].t);
+        free(processes[i].marks);
+    }
+    if(mapped != NULL)
+        stopBlocks();
     free(processes);
+    if(resultsFd >= 0)
+        close(resultsFd);
+    free(rrRemaining);
+    free(rrDone);
+    free(waitHistograms);
+    free(indexFile);
+    if(histogramOut != NULL)
+        fclose(histogramOut);
     processes = NULL;
-    exit(1);
+    exit(status);
 }
 
 /**
@@ -205,8 +2235,161 @@ void terminate(){
 */
 int main(int argc, char* argv[]){
     char* datafile;
-    int i, dflen;
-    datafile = argv[1];
+    const char* mcShape = "8:100";
+    char* token;
+    int opt, dflen, k, numPolicies = 0, benchRepeats = 0, policies[MAX_POLICIES];
+    static struct option options[] = {
+        {"checkpoint", required_argument, NULL, 'c'},
+        {"checkpoint-every", required_argument, NULL, 'e'},
+        {"resume", required_argument, NULL, 'r'},
+        {"histograms", required_argument, NULL, 'h'},
+        {"build-index", no_argument, NULL, 'b'},
+        {"index-every", required_argument, NULL, 'e'},
+        {"ticks", required_argument, NULL, 't'},
+        {"policy", required_argument, NULL, 'p'},
+        {"quantum", required_argument, NULL, 'q'},
+        {"bench", required_argument, NULL, 'B'},
+        {"results", required_argument, NULL, 'o'},
+        {"results-format", required_argument, NULL, 'f'},
+        {"summary-only", no_argument, NULL, 's'},
+        {"memory-budget", required_argument, NULL, 'm'},
+        {"monte-carlo", required_argument, NULL, 'M'},
+        {"mc-shape", required_argument, NULL, 'S'},
+        {"mc-dist", required_argument, NULL, 'D'},
+        {"mc-seed", required_argument, NULL, 'R'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"verify", required_argument, NULL, 'V'},
+        {"max-ns", required_argument, NULL, 'N'},
+        {"max-ratio", required_argument, NULL, 'X'},
+        {"trace", required_argument, NULL, 'T'},
+        {"replay", required_argument, NULL, 'P'},
+        {"sweep-alpha", required_argument, NULL, 'A'},
+        {"numa", no_argument, NULL, 'U'},
+        {NULL, 0, NULL, 0}
+    };
+    while((opt = getopt_long(argc, argv, "", options, NULL)) != -1){
+        switch(opt){
+            case 'c': checkpointFile = optarg; break;
+            case 'e': markEvery = atoi(optarg); break;
+            case 'r': resumeFile = optarg; break;
+            case 'h': histogramFile = optarg; break;
+            case 'b': buildIndex = 1; break;
+            case 't':
+                if(sscanf(optarg, "%d:%d", &windowFrom, &windowTo) != 2 || windowFrom < 0 || windowTo <= windowFrom){
+                    printf("Tick window must be given as A:B with 0 <= A < B.\n");
+                    exit(1);
+                }
+                break;
+            case 'p':
+                if(numPolicies == MAX_POLICIES)
+                    break;
+                if(strcmp(optarg, "sjf") == 0)
+                    policies[numPolicies++] = POLICY_SJF;
+                else if(strcmp(optarg, "sjfl") == 0)
+                    policies[numPolicies++] = POLICY_SJFL;
+                else if(strcmp(optarg, "priority") == 0)
+                    policies[numPolicies++] = POLICY_PRIORITY;
+                else if(strcmp(optarg, "rr") == 0)
+                    policies[numPolicies++] = POLICY_RR;
+                else {
+                    printf("Unknown policy %s. Choose sjf, sjfl, priority or rr.\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'q': quantum = atoi(optarg); break;
+            case 'B': benchRepeats = atoi(optarg); break;
+            case 'o': resultsFile = optarg; break;
+            case 'f':
+                if(strcmp(optarg, "csv") == 0)
+                    resultsCsv = 1;
+                else if(strcmp(optarg, "binary") != 0){
+                    printf("Results format must be binary or csv.\n");
+                    exit(1);
+                }
+                break;
+            case 's': summaryOnly = 1; break;
+            case 'm': memoryBudget = atol(optarg) * 1024L * 1024L; break;
+            case 'M': mcScenarios = atol(optarg); break;
+            case 'S': mcShape = optarg; break;
+            case 'D':
+                if(sscanf(optarg, "exp:%lf", &mcParams[0]) == 1)
+                    mcDistribution = MC_EXPONENTIAL;
+                else if(sscanf(optarg, "uniform:%lf:%lf", &mcParams[0], &mcParams[1]) == 2
+                        && mcParams[0] <= mcParams[1])
+                    mcDistribution = MC_UNIFORM;
+                else if(sscanf(optarg, "bimodal:%lf:%lf:%lf", &mcParams[0], &mcParams[1], &mcParams[2]) == 3)
+                    mcDistribution = MC_BIMODAL;
+                else {
+                    printf("Distribution must be exp:MEAN, uniform:MIN:MAX with MIN <= MAX, or bimodal:SHORT:LONG:P.\n");
+                    exit(1);
+                }
+                break;
+            case 'R': mcSeed = strtoull(optarg, NULL, 0); break;
+            case 'j': mcWorkers = atoi(optarg); break;
+            case 'V': verifyTraces = atol(optarg); break;
+            case 'N': maxNanoseconds = atof(optarg); break;
+            case 'X': maxRatio = atof(optarg); break;
+            case 'T': traceFile = optarg; break;
+            case 'P': replayFile = optarg; break;
+            case 'A':
+                for(token = strtok(optarg, ","); token != NULL && numAlphas < MAX_ALPHAS; token = strtok(NULL, ","))
+                    alphas[numAlphas++] = strtof(token, NULL);
+                break;
+            case 'U': numaPlacement = 1; break;
+            default:
+                printf("Usage: %s [--policy sjf|sjfl|priority|rr]... [--quantum Q] [--bench N [--max-ns X] [--max-ratio R] [--mc-shape N:T]] [--verify N] [--trace FILE] [--replay FILE [--ticks A:B]] [--sweep-alpha A,B,... [--numa] DATAFILE...] [--results FILE [--results-format binary|csv]] [--summary-only] [--memory-budget MB] [--monte-carlo S [--mc-shape N:T] [--mc-dist D] [--mc-seed X] [--jobs W]] [--checkpoint FILE [--checkpoint-every N]] [--resume FILE] [--histograms FILE] [--build-index [--index-every N] | --ticks A:B] DATAFILE\n", argv[0]);
+                exit(1);
+        }
+    }
+    if(quantum <= 0){
+        printf("Quantum must be positive.\n");
+        exit(1);
+    }
+    if(numPolicies == 0){
+        policies[numPolicies++] = POLICY_SJF;
+        policies[numPolicies++] = POLICY_SJFL;
+    }
+    if(resumeFile != NULL || windowFrom >= 0 || buildIndex){
+        policies[0] = POLICY_SJFL;
+        numPolicies = 1;
+    }
+    if((checkpointFile != NULL || buildIndex) && markEvery <= 0)
+        markEvery = 1000;
+    if(checkpointFile == NULL && !buildIndex)
+        markEvery = 0;
+    if(replayFile != NULL){
+        replayTrace();
+        terminate(0);
+    }
+    if(verifyTraces > 0){
+        if(memoryBudget > 0 || checkpointFile != NULL || resumeFile != NULL || windowFrom >= 0 || buildIndex){
+            printf("Verification generates its traces in memory; drop --memory-budget, --checkpoint, --resume, --ticks and --build-index.\n");
+            exit(1);
+        }
+        terminate(runVerify(verifyTraces) > 0);
+    }
+    if(numAlphas > 0){
+        if(optind >= argc){
+            printf("No data file name provided. This is a required field.\n");
+            exit(1);
+        }
+        if(memoryBudget > 0 || resumeFile != NULL || windowFrom >= 0 || buildIndex || checkpointFile != NULL){
+            printf("The alpha sweep loads every trace whole; drop --memory-budget, --resume, --ticks, --checkpoint and --build-index.\n");
+            exit(1);
+        }
+        runSweep(argc - optind, argv + optind);
+        terminate(0);
+    }
+    if(mcScenarios > 0){
+        if(memoryBudget > 0 || checkpointFile != NULL || resumeFile != NULL || windowFrom >= 0 || buildIndex
+           || traceFile != NULL || resultsFile != NULL || histogramFile != NULL){
+            printf("Monte Carlo scenarios are generated in memory; drop --memory-budget, --checkpoint, --resume, --ticks, --build-index, --trace, --results and --histograms.\n");
+            exit(1);
+        }
+        runMonteCarlo(mcShape);
+        terminate(0);
+    }
+    datafile = argv[optind];
     if(datafile != NULL){
         dflen = strlen(datafile);
         if(dflen >= 5
@@ -218,13 +2401,51 @@ int main(int argc, char* argv[]){
             printf("Data file has an invalid name or does not exist.\n");
             exit(1);
         }
+    } else if(benchRepeats > 0){
+        generateTrace(mcShape);
+        printf("Benchmarking a generated trace of %d processes x %d ticks\n\n", numProcesses, numTicks);
     } else {
         printf("No data file name provided. This is a required field.\n");
         exit(1);
     }
-    printSJF();
-    printf("\n");
-    printSJFL();
-    terminate();
+    rrRemaining = (int*)malloc(numProcesses * sizeof(int));
+    rrDone = (int*)malloc(numProcesses * sizeof(int));
+    if(benchRepeats > 0 && (memoryBudget > 0 || firstTick > 0 || lastTick < numTicks
+                            || checkpointFile != NULL || buildIndex)){
+        printf("Benchmarks need the whole trace in memory; drop --memory-budget, --resume, --ticks, --checkpoint and --build-index.\n");
+        terminate(1);
+    }
+    if(benchRepeats > 0){
+        terminate(runBenchmark(benchRepeats) > 0);
+    }
+    if(histogramFile != NULL)
+        startHistograms();
+    if(resultsFile != NULL)
+        startResults();
+    if(traceFile != NULL)
+        startTrace();
+    for(k = 0; k < numPolicies; k++){
+        if(k > 0)
+            printf("\n");
+        switch(policies[k]){
+            case POLICY_SJF: printSJF(); break;
+            case POLICY_PRIORITY: printPriority(); break;
+            case POLICY_RR: printRoundRobin(); break;
+            case POLICY_SJFL:
+                if(checkpointFile != NULL)
+                    startCheckpoints();
+                if(buildIndex)
+                    startIndex();
+                printSJFL();
+                if(checkpointFile != NULL)
+                    stopCheckpoints();
+                if(buildIndex)
+                    stopIndex();
+                break;
+        }
+    }
+    if(traceFile != NULL)
+        stopTrace();
+    terminate(0);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+# Runs PROGRAM on TRACE in one alternate MODE and fails unless it agrees
+# with a plain in-memory run:
+#   memory  - --memory-budget 1 must print exactly the plain output
+#   resume  - resuming from a --checkpoint must give the plain totals
+#   window  - a --ticks window seeded from --build-index must print the
+#             plain schedule from its first tick on, and the same totals
+function(run output)
+    execute_process(COMMAND ${PROGRAM} ${ARGN} ${TRACE}
+                    OUTPUT_VARIABLE text
+                    RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${PROGRAM} ${ARGN} ${TRACE} exited with ${status}\n${text}")
+    endif()
+    set(${output} "${text}" PARENT_SCOPE)
+endfunction()
+
+function(totals output text)
+    string(REGEX MATCHALL "(Turnaround time|Waiting time|Estimation Error): [0-9-]+" lines "${text}")
+    set(${output} "${lines}" PARENT_SCOPE)
+endfunction()
+
+function(expect_equal what expected actual)
+    if(NOT expected STREQUAL actual)
+        message(FATAL_ERROR "${MODE}: ${what} differ from the plain run\n"
+                            "plain:\n${expected}\n${MODE}:\n${actual}")
+    endif()
+endfunction()
+
+if(MODE STREQUAL "memory")
+    run(plain)
+    run(actual --memory-budget 1)
+    expect_equal("outputs" "${plain}" "${actual}")
+elseif(MODE STREQUAL "resume")
+    get_filename_component(dir ${TRACE} DIRECTORY)
+    file(REMOVE ${dir}/resume.ckp)
+    run(plain --policy sjfl --summary-only)
+    totals(expected "${plain}")
+    run(first --policy sjfl --summary-only --checkpoint ${dir}/resume.ckp --checkpoint-every 1000)
+    totals(actual "${first}")
+    expect_equal("checkpointed totals" "${expected}" "${actual}")
+    run(resumed --policy sjfl --summary-only --resume ${dir}/resume.ckp)
+    if(NOT resumed MATCHES "Resuming from checkpoint at tick [1-9]")
+        message(FATAL_ERROR "resume: the run did not start from the checkpoint\n${resumed}")
+    endif()
+    totals(actual "${resumed}")
+    expect_equal("resumed totals" "${expected}" "${actual}")
+elseif(MODE STREQUAL "window")
+    run(plain --policy sjfl)
+    run(built --policy sjfl --build-index --index-every 1000)
+    run(window --policy sjfl --ticks ${FROM}:${TO})
+    if(NOT window MATCHES "Seeded from index snapshot at tick [1-9]")
+        message(FATAL_ERROR "window: the run was not seeded from the index\n${window}")
+    endif()
+    string(FIND "${plain}" "Simulating ${FROM}th tick" start)
+    string(SUBSTRING "${plain}" ${start} -1 expected)
+    string(FIND "${window}" "Simulating ${FROM}th tick" start)
+    string(SUBSTRING "${window}" ${start} -1 actual)
+    expect_equal("schedules" "${expected}" "${actual}")
+else()
+    message(FATAL_ERROR "Unknown mode ${MODE}")
+endif()
@@ -0,0 +1,17 @@
+# Runs PROGRAM on DATAFILE from WORKING_DIRECTORY and fails unless its
+# standard output matches EXPECTED byte for byte. DATAFILE is passed as
+# given because the program echoes it in the "Importing data" line.
+execute_process(COMMAND ${PROGRAM} ${DATAFILE}
+                WORKING_DIRECTORY ${WORKING_DIRECTORY}
+                OUTPUT_VARIABLE actual
+                RESULT_VARIABLE status)
+if(NOT status EQUAL 0)
+    message(FATAL_ERROR "${PROGRAM} ${DATAFILE} exited with ${status}")
+endif()
+file(READ ${EXPECTED} expected)
+if(NOT actual STREQUAL expected)
+    get_filename_component(name ${EXPECTED} NAME_WE)
+    file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/${name}.actual "${actual}")
+    message(FATAL_ERROR "Output for ${DATAFILE} differs from ${EXPECTED}; "
+                        "see ${CMAKE_CURRENT_BINARY_DIR}/${name}.actual")
+endif()
@@ -0,0 +1,22 @@
+# Writes a PROCESSES x TICKS data file to OUTPUT. Each process repeats a
+# 97-tick burst pattern of its own, which is enough variety to reorder
+# the schedule every tick while staying quick to generate in CMake.
+set(period 97)
+math(EXPR repeats "(${TICKS} + ${period} - 1) / ${period}")
+set(text "${TICKS}\n${PROCESSES}\n")
+math(EXPR last "${PROCESSES} - 1")
+foreach(j RANGE ${last})
+    math(EXPR tau "${j} % 13 + 1")
+    math(EXPR alpha "${j} % 9 + 1")
+    set(pattern "")
+    foreach(k RANGE 1 ${period})
+        math(EXPR burst "(${k} * ${k} * 7 + ${j} * 11) % 29 + ${j} % 3")
+        string(APPEND pattern "${burst}\n")
+    endforeach()
+    string(REPEAT "${pattern}" ${repeats} bursts)
+    string(REGEX MATCHALL "[^\n]+\n" tokens "${bursts}")
+    list(SUBLIST tokens 0 ${TICKS} tokens)
+    string(REPLACE ";" "" bursts "${tokens}")
+    string(APPEND text "${j}\n${tau}\n0.${alpha}\n${bursts}")
+endforeach()
+file(WRITE ${OUTPUT} "${text}")